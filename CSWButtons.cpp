@@ -11,22 +11,96 @@
 
 #include "CSWButtons.h"
 using namespace swbtns;
-#include <Arduino.h>
 #include <vector>
 #include <deque>
 #include <string>
 #include <sstream>
+#include <algorithm>
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <Wire.h>
+#if defined(ESP32)
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#endif
+#else
+// Host (Linux) build. There are no Arduino pins here - the buttons come from the host backends
+// (see CSWButtonsGpiod.h) through CSWButtons::pushEvent(), so the pin functions are just stubs.
+#include <time.h>
+#define LOW 0
+#define HIGH 1
+#define INPUT 1
+#define INPUT_PULLUP 5
+#define CHANGE 3
+#define FALLING 2
+using std::max;
+using std::min;
+/// @brief CLOCK_MONOTONIC in ms since the first call - like millis() since the boot, so the int times of the click stacks
+/// do not overflow after 24.8 days of the system uptime. Static - the application may have its own millis().
+static unsigned long millis() {
+  static long long epoch_ns = -1;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  long long now_ns = ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  if(epoch_ns < 0) epoch_ns = now_ns;
+  return (unsigned long)((now_ns - epoch_ns) / 1000000LL);
+}
+// Weak - the application (or a test) may provide the real ones.
+__attribute__((weak)) void pinMode(uint8_t pin, uint8_t mode) {}
+__attribute__((weak)) void attachInterrupt(uint8_t pin, VoidFunctionWithNoParameters handler, int mode) {}
+__attribute__((weak)) void detachInterrupt(uint8_t pin) {}
+__attribute__((weak)) int digitalRead(uint8_t pin) { return HIGH; }
+__attribute__((weak)) int analogRead(uint8_t pin) { return 0x7FFF; } //above any ladder band - nothing is pressed
+#endif
 
 #define DEBUG 0
 
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+// The interrupt handlers do not rely on millis()/digitalRead() of the core being in IRAM (it depends on the
+// arduino-esp32 version and on CONFIG_ARDUINO_ISR_IRAM): on the ESP32 they read the esp_timer and the GPIO
+// input registers directly. esp_timer_get_time() is IRAM-safe, and millis() is esp_timer_get_time()/1000 too.
+static inline unsigned long IRAM_ATTR _isrMillis() {
+  #if defined(ARDUINO) && defined(ESP32)
+  return (unsigned long)(esp_timer_get_time() / 1000ULL);
+  #else
+  return millis();
+  #endif
+}
+static inline int IRAM_ATTR _isrReadPin(uint8_t pin) {
+  #if defined(ARDUINO) && defined(ESP32)
+  #if defined(GPIO_IN1_REG)
+  if(pin >= 32) return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+  #endif
+  return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+  #else
+  return digitalRead(pin);
+  #endif
+}
+
 typedef void (*VoidFunctionWithNoParameters) (void);
 typedef void (*VoidFunctionWithOneParameter) (int);
+typedef void (*VoidFunctionWithTwoParameters) (int, int);
 
 std::vector<uint8_t> btnPins;
 
 int CSWButtons::button_click_flow_limit=5;
 int CSWButtons::button_recheck_interval_longpress_ms=500;
 int CSWButtons::button_recheck_interval_ms=1000;
+int CSWButtons::ladder_sample_interval_ms=20;
+int CSWButtons::ladder_stable_samples=3;
+int CSWButtons::button_debounce_ms=100;
+int CSWButtons::storm_edge_limit=30;
+int CSWButtons::storm_window_ms=250;
+int CSWButtons::storm_poll_interval_ms=20;
+int CSWButtons::storm_settle_ms=1000;
 
 template<typename ValueType>
 std::string stringulate(ValueType v)
@@ -50,6 +124,145 @@ typedef struct Record2
       std::string name;
 }_click_event;
 
+typedef struct Record6
+{
+      int pin;
+      std::vector<int> tiers; //hold thresholds in ms, sorted
+      VoidFunctionWithTwoParameters hold_function=__null;
+      VoidFunctionWithTwoParameters progress_function=__null;
+      int progress_interval_ms=50;
+      bool held=false;
+      bool consumed=false; //a tier was fired - the release is not a click or longpress anymore
+      int time_pressed=-1;
+      int next_tier=0;
+      int next_progress=0; //ms since the press
+      VoidFunctionWithTwoParameters repeat_function=__null;
+      int repeat_delay_ms=400;
+      int repeat_interval_ms=200;
+      int repeat_min_interval_ms=40;
+      int repeat_accel_percent=80; //every next interval is this percent of the previous one
+      int repeat_curr_interval=0;
+      int repeat_seq=0;
+      int next_repeat=0; //ms since the press
+}_btn_hold;
+
+typedef struct Record7
+{
+      int pin;
+      VoidFunctionWithTwoParameters event_function=__null;
+      int pending=0; //presses not handed to the application yet
+      bool busy=false; //event_function is running right now
+}_btn_coalesced;
+
+typedef struct Record3
+{
+      int adc_pin;
+      int hysteresis=40;
+      int adc_value=-1;
+      int active=-1; //index of the band which is held now, -1 - nothing is pressed
+      int candidate=-1; //band the value has moved to, not confirmed yet
+      int candidate_samples=0; //amount of the samples in a row in the candidate band
+      unsigned long candidate_time=0; //first sample in the candidate band
+      std::vector<ladderThreshold> thresholds; //sorted by adc_max
+}_btn_ladder;
+
+// The interrupt handlers do not touch the click stacks (they allocate) - they only put the raw edges into
+// these preallocated queues, which are drained into the click stacks by the "tick".
+// One producer (the interrupt) moves head, one consumer (the "tick") moves tail.
+#define CSWBUTTONS_MAX_BUTTONS 10
+#define CSWBUTTONS_EDGE_QUEUE_SIZE 16
+typedef struct Record5
+{
+      uint8_t pin;
+      volatile uint8_t head;
+      volatile uint8_t tail;
+      volatile uint8_t latest_level; //level seen by the last interrupt, the debounced ones too
+      volatile unsigned long latest_time;
+      volatile uint32_t dropped; //edges lost: queue overflow or the pin is storming
+      volatile uint32_t debounced; //edges folded into the neighbour: debounce or the polling integrator
+      volatile unsigned long last_edge_time;
+      volatile unsigned long window_start;
+      volatile uint16_t window_edges;
+      volatile bool storming; //set by the interrupt, the "tick" moves the pin to polling
+      volatile unsigned long edge_time[CSWBUTTONS_EDGE_QUEUE_SIZE];
+      volatile uint8_t edge_type[CSWBUTTONS_EDGE_QUEUE_SIZE];
+      //the fields below are used only by the "tick"
+      uint8_t level; //level given to the click stacks
+      bool polling;
+      int integrator;
+      uint8_t raw_level;
+      unsigned long last_poll_time;
+      unsigned long last_raw_change;
+}_btn_edges;
+
+#define CSWBUTTONS_STORM_INTEGRATOR_MAX 4
+
+DRAM_ATTR _btn_edges btnEdges[CSWBUTTONS_MAX_BUTTONS];
+
+std::vector<_btn_ladder> btnLadders;
+unsigned long lastLadderSampleTime = 0;
+
+typedef struct Record4
+{
+      int int_pin;
+      uint8_t i2c_address;
+      int expander_type;
+      int first_button;
+      ExpanderReadFunction read_function;
+      uint16_t inputs=0xFFFF; //last snapshot of the inputs, the buttons are active LOW
+      uint16_t delivered=0xFFFF; //levels already given to the click stacks
+      bool synced=false; //the first read is the snapshot - the buttons held at the start do not become the presses
+      unsigned long edge_time[16]; //last delivered edge of every input, for the debounce
+      volatile bool pending=false; //set by the INT line interrupt, the read is done in the "tick"
+      volatile unsigned long int_time=0;
+}_btn_expander;
+
+// The expanders are kept in the plain array as the interrupt handlers are accessing them.
+#define CSWBUTTONS_MAX_EXPANDERS 4
+_btn_expander btnExpanders[CSWBUTTONS_MAX_EXPANDERS];
+int btnExpandersCount = 0;
+
+// Wake from the deep sleep by the button. The press which woke the chip is put into the click stacks by attachInterrupts().
+int wakeExt0Pin = -1;
+int wakeTime = -1;
+int wakeLatency = -1;
+bool wakeLatencyPending = false;
+uint64_t wakePins = 0; //the pins whose press was seeded by the wake
+
+/// @brief Default wake cause provider - the ESP32 ext0/ext1 wakeup.
+/// @param wake_time_ms the moment of the wake on the millis() scale - the chip boots after the deep sleep, so it is 0
+/// @return mask of the pins which woke the chip (bit N - GPIO N), 0 if the chip was not woken by the button
+uint64_t _espWakeCause(int * wake_time_ms) {
+  *wake_time_ms = 0;
+  #if defined(ESP32)
+  switch(esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_EXT0:
+      return (wakeExt0Pin >= 0) ? (1ULL << wakeExt0Pin) : 0;
+    case ESP_SLEEP_WAKEUP_EXT1:
+      return esp_sleep_get_ext1_wakeup_status();
+    default:
+      return 0;
+  }
+  #else
+  return 0;
+  #endif
+}
+WakeCauseFunction wakeCauseFunction = _espWakeCause;
+
+/// @brief Called when the user callback of the pin is about to be executed - takes the wake-to-callback latency once after the wake,
+/// when it is the callback of the pin which woke the chip.
+/// @param pin 
+void _wakeCallbackFired(int pin) {
+  if(!wakeLatencyPending) return;
+  if((pin < 0) || (pin >= 64) || !(wakePins & (1ULL << pin))) return;
+  wakeLatencyPending = false;
+  wakeLatency = millis() - wakeTime;
+  #if defined(DEBUG) && DEBUG>=1
+  Serial.print("CSWBUTTONS: Wake to callback latency(ms): ");
+  Serial.println(wakeLatency);
+  #endif
+}
+
 class SWbtns
 {
   private:
@@ -69,6 +282,17 @@ class SWbtns
   bool buttonsClickStackAltLocked=false;
   int getClickStackIndex(int pin, bool is_alt=false);
 
+  // The hold events are fired while the button is down. Instead of checking all of the buttons on every tick
+  // only the nearest deadline is kept - the tick does nothing until it comes.
+  std::vector<_btn_hold> holdButtons;
+  bool holdDeadlineArmed=false;
+  int holdNextDeadline=0;
+  std::vector<_btn_coalesced> coalescedButtons;
+  int getCoalescedIndex(int pin, bool create=false);
+  int getHoldIndex(int pin, bool create=false);
+  bool getHoldDeadline(const _btn_hold &hold, int * deadline);
+  void scheduleHolds(void);
+
   public:
   bool checkEventsBlocked() {
     return _eventsBlocked;
@@ -122,6 +346,7 @@ class SWbtns
       #if defined(DEBUG) && DEBUG>=10
       Serial.println("CSWBUTTONS: Function found. Execution!");
       #endif
+      _wakeCallbackFired(pin);
       f(pin);
     } else {
       #if defined(DEBUG) && DEBUG>=10
@@ -166,6 +391,7 @@ class SWbtns
       Serial.print("CSWBUTTONS: Longpress click duration(ms): ");
       Serial.println(click_length);
       #endif
+      _wakeCallbackFired(pin);
       f(pin);
     } else {
       #if defined(DEBUG) && DEBUG>=10
@@ -276,7 +502,7 @@ class SWbtns
   
   const static int CLICK=0;
   const static int UNCLICK=1;
-  void addEventToClickStack(int pin,int click_type=CLICK, int ts=-1);//click_type: 0-click, 1-unclick; ts = timestamp, optional
+  void addEventToClickStack(int pin,int click_type, int ts);//click_type: 0-click, 1-unclick; ts = timestamp
   bool checkClickStackDone(int pin, bool is_alt=false);
   void clearClickStack(int pin, bool is_alt=false);
   void clearAllClickStacks();
@@ -284,6 +510,16 @@ class SWbtns
   void setButtonStackFimit(int l);
   int getButtonStackFimit(void);
   void processStack(void);
+  void onhold(int pin, const int * tiers_ms, int count, VoidFunctionWithTwoParameters onhold_function);
+  void onholdprogress(int pin, VoidFunctionWithTwoParameters onprogress_function, int interval_ms);
+  void onrepeat(int pin, VoidFunctionWithTwoParameters onrepeat_function, int delay_ms, int interval_ms, int min_interval_ms, int accel_percent);
+  void trackHold(int pin, int click_type, int ts);
+  void processHolds(void);
+  bool holdBlocksClick(int pin);
+  void oncoalescedclick(int pin, VoidFunctionWithTwoParameters onclick_function);
+  bool coalesceEvent(int pin, int click_type);
+  int takePendingClicks(int pin);
+  void processCoalesced(void);
   
   _btn_struct operator [] (int pin)
   {
@@ -336,43 +572,270 @@ bool _callbackMulticlick(int pin, int _click_count,bool longPress=false,int clic
   return false;
 }
 
-/// @brief System-called function which is called when a click event was generated
-/// @param pinNum 
-void handleInterrupt(int pinNum) {
-  int pin=btns.getPinByNum(pinNum);
-  if(btns.checkEventsBlocked()) {
+/// @brief Returns the index of the ladder band the ADC value belongs to, -1 if it is above all of them (nothing is pressed)
+/// @param ladder 
+/// @param adc_value 
+/// @return 
+int _ladderBand(const _btn_ladder &ladder, int adc_value) {
+  for(int i=0;i<ladder.thresholds.size();i++) {
+    if(adc_value <= ladder.thresholds[i].adc_max) return i;
+  }
+  return -1;
+}
+
+/// @brief Checks if the ADC value is still inside of the band (widened by the hysteresis), so the noise on the band border does not produce the click events
+/// @param ladder 
+/// @param band index of the band, -1 for "nothing is pressed"
+/// @param adc_value 
+/// @return 
+bool _ladderBandHolds(const _btn_ladder &ladder, int band, int adc_value) {
+  int sz = ladder.thresholds.size();
+  if(band == -1) return adc_value > ladder.thresholds[sz-1].adc_max - ladder.hysteresis;
+  int lo = (band > 0) ? ladder.thresholds[band-1].adc_max + 1 : 0;
+  int hi = ladder.thresholds[band].adc_max;
+  return (adc_value >= lo - ladder.hysteresis) && (adc_value <= hi + ladder.hysteresis);
+}
+
+/// @brief Samples all of the resistor ladders. Called by the "tick" function, not more often than ladder_sample_interval_ms.
+/// All of the ADC channels are read in one pass first and only then the values are mapped to the logical buttons, so the ADC is busy as short as possible.
+/// The new band is taken only after ladder_stable_samples samples in a row inside of it: a sample during the contact bounce
+/// or on the way between two voltages (passing the neighbouring bands) does not become a click. The events get the time of the first of these samples.
+void _processLadders() {
+  if(btnLadders.size() == 0) return;
+  unsigned long currTime = millis();
+  if(currTime - lastLadderSampleTime < CSWButtons::ladder_sample_interval_ms) return;
+  lastLadderSampleTime = currTime;
+  for(int i=0;i<btnLadders.size();i++) {
+    btnLadders[i].adc_value = analogRead(btnLadders[i].adc_pin);
+  }
+  if(btns.checkEventsBlocked()) return;
+  for(int i=0;i<btnLadders.size();i++) {
+    _btn_ladder &ladder = btnLadders[i];
+    if(_ladderBandHolds(ladder, ladder.active, ladder.adc_value)) {
+      ladder.candidate_samples = 0;
+      continue;
+    }
+    int band = _ladderBand(ladder, ladder.adc_value);
+    if((ladder.candidate_samples == 0) || (band != ladder.candidate)) {
+      ladder.candidate = band;
+      ladder.candidate_samples = 0;
+      ladder.candidate_time = currTime;
+    }
+    if(++ladder.candidate_samples < CSWButtons::ladder_stable_samples) continue;
+    ladder.candidate_samples = 0;
     #if defined(DEBUG) && DEBUG>=1
-    Serial.println("CSWBUTTONS: BUTTONS: Blocking onclick!");
+    Serial.print("CSWBUTTONS: LADDER on pin ");
+    Serial.print(ladder.adc_pin);
+    Serial.print(" moved to band ");
+    Serial.print(band);
+    Serial.print("; ADC value: ");
+    Serial.println(ladder.adc_value);
     #endif
-    return;
+    if(ladder.active != -1) btns.addEventToClickStack(ladder.thresholds[ladder.active].button, SWbtns::UNCLICK, ladder.candidate_time);
+    if(band != -1) btns.addEventToClickStack(ladder.thresholds[band].button, SWbtns::CLICK, ladder.candidate_time);
+    ladder.active = band;
   }
-  uint8_t eventType = 0; //0 - pressed, 1 - unpressed
-  uint8_t buttonState = digitalRead(pin);
-  eventType = (buttonState == LOW) ? 0 : 1;
-  #if defined(DEBUG) && DEBUG>=10
-  Serial.println("CSWBUTTONS: Calling the addEventToClickStack.");
-  Serial.print("CSWBUTTONS: event type:");
-  Serial.println(eventType);
-  delay(500);
-  #endif
-  btns.addEventToClickStack(pin,eventType);
 }
-unsigned long lastPressedTime = millis();
-#define PIN_HANDLER(pin) \
-void pin_handler_##pin (void) \
-{ \
-  unsigned long pressedTime = millis();\
-  if(pressedTime-lastPressedTime >= 50) {lastPressedTime=pressedTime;handleInterrupt(pin);} \
+
+/// @brief Amount of the inputs of the expander
+/// @param expander_type 
+/// @return 
+int _expanderWidth(int expander_type) {
+  return (expander_type == CSWButtons::EXPANDER_PCF8574) ? 8 : 16;
+}
+
+/// @brief Default reader of the expander inputs - one I2C transaction for all of the 8/16 inputs. Wire.begin() has to be called by the sketch.
+/// @param i2c_address 
+/// @param expander_type 
+/// @param inputs 
+/// @return false if the expander did not answer
+#if defined(ARDUINO)
+bool _expanderWireRead(uint8_t i2c_address, int expander_type, uint16_t * inputs) {
+  if(expander_type == CSWButtons::EXPANDER_MCP23017) {
+    Wire.beginTransmission(i2c_address);
+    Wire.write(0x12); //GPIOA, GPIOB follows it
+    if(Wire.endTransmission(false) != 0) return false;
+  }
+  uint8_t width = _expanderWidth(expander_type) / 8;
+  if(Wire.requestFrom(i2c_address, width) != width) return false;
+  uint16_t v = Wire.read();
+  if(width == 2) v |= ((uint16_t)Wire.read()) << 8;
+  else v |= 0xFF00;
+  *inputs = v;
+  return true;
+}
+
+/// @brief Writes the register of the MCP23017
+void _mcp23017Write(uint8_t i2c_address, uint8_t reg, uint8_t value) {
+  Wire.beginTransmission(i2c_address);
+  Wire.write(reg);
+  Wire.write(value);
+  Wire.endTransmission();
+}
+
+/// @brief Prepares the expander, so all of its pins are inputs with pullups and the change of any of them pulls the INT line.
+/// Only done for the default (Wire) reader - with the custom reader the device is the responsibility of the sketch.
+/// @param expander 
+void _expanderInit(_btn_expander &expander) {
+  if(expander.read_function != _expanderWireRead) return;
+  if(expander.expander_type == CSWButtons::EXPANDER_MCP23017) {
+    _mcp23017Write(expander.i2c_address, 0x0A, 0x40); //IOCON: MIRROR - one INT line for both ports
+    _mcp23017Write(expander.i2c_address, 0x0C, 0xFF); //GPPUA
+    _mcp23017Write(expander.i2c_address, 0x0D, 0xFF); //GPPUB
+    _mcp23017Write(expander.i2c_address, 0x04, 0xFF); //GPINTENA
+    _mcp23017Write(expander.i2c_address, 0x05, 0xFF); //GPINTENB
+  } else {
+    //quasi-bidirectional pins are inputs when HIGH is written
+    Wire.beginTransmission(expander.i2c_address);
+    Wire.write(0xFF);
+    if(expander.expander_type == CSWButtons::EXPANDER_PCF8575) Wire.write(0xFF);
+    Wire.endTransmission();
+  }
+}
+#else
+// No Wire on the host - the expander there works only with the custom reader (e.g. a mocked I2C device).
+bool _expanderWireRead(uint8_t i2c_address, int expander_type, uint16_t * inputs) {
+  return false;
+}
+void _expanderInit(_btn_expander &expander) {
+}
+#endif
+
+/// @brief Reads the expanders which have signalled a change over their INT line and turns the difference with the previous snapshot into click/unclick events.
+/// One I2C transaction per change, no matter how many buttons are on the expander.
+/// The inputs are debounced the same way as the pins: the edge within button_debounce_ms after the previous one is held back
+/// and the final level is delivered by a later tick when that time is over.
+void _processExpanders() {
+  unsigned long currTime = millis();
+  for(int i=0;i<btnExpandersCount;i++) {
+    _btn_expander &expander = btnExpanders[i];
+    int ts = currTime;
+    if(expander.pending) {
+      ts = expander.int_time;
+      expander.pending = false;
+      uint16_t inputs;
+      if(!expander.read_function(expander.i2c_address, expander.expander_type, &inputs)) {
+        #if defined(DEBUG) && DEBUG>=1
+        Serial.print("CSWBUTTONS: EXPANDER read failed, address: ");
+        Serial.println(expander.i2c_address);
+        #endif
+        expander.pending = true; //retry during the next tick
+        continue;
+      }
+      expander.inputs = inputs;
+      if(!expander.synced) {
+        expander.synced = true;
+        expander.delivered = inputs;
+      }
+    }
+    uint16_t changed = expander.inputs ^ expander.delivered;
+    if(!changed) continue;
+    if(btns.checkEventsBlocked()) {
+      expander.delivered = expander.inputs;
+      continue;
+    }
+    for(int bit=0;bit<_expanderWidth(expander.expander_type);bit++) {
+      if(!(changed & (1 << bit))) continue;
+      if(currTime - expander.edge_time[bit] < CSWButtons::button_debounce_ms) continue;
+      expander.edge_time[bit] = currTime;
+      expander.delivered ^= (1 << bit);
+      bool pressed = !(expander.inputs & (1 << bit));
+      btns.addEventToClickStack(expander.first_button + bit, pressed ? SWbtns::CLICK : SWbtns::UNCLICK, ts);
+    }
+  }
+}
+
+/// @brief Moves the edges queued by the interrupt handlers into the click stacks. Called by the "tick" function.
+void _processEdges() {
+  for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+    _btn_edges &edges = btnEdges[i];
+    while(edges.tail != edges.head) {
+      uint8_t tail = edges.tail;
+      int ts = edges.edge_time[tail];
+      int eventType = edges.edge_type[tail];
+      edges.tail = (tail + 1) % CSWBUTTONS_EDGE_QUEUE_SIZE;
+      #if defined(DEBUG) && DEBUG>=10
+      Serial.print("CSWBUTTONS: Calling the addEventToClickStack. Event type:");
+      Serial.println(eventType);
+      #endif
+      btns.addEventToClickStack(edges.pin, eventType, ts);
+      edges.level = eventType;
+    }
+    // The edge swallowed by the debounce may be the last one (the quick tap loses its release this way).
+    // When the debounce time is over the final level is given to the click stacks.
+    if(edges.storming || edges.polling) continue;
+    uint8_t latest_level = edges.latest_level;
+    if((latest_level != edges.level) && (millis() - edges.last_edge_time >= CSWButtons::button_debounce_ms)) {
+      #if defined(DEBUG) && DEBUG>=10
+      Serial.print("CSWBUTTONS: Delivering the debounced level of the pin ");
+      Serial.println(edges.pin);
+      #endif
+      btns.addEventToClickStack(edges.pin, latest_level, edges.latest_time);
+      edges.level = latest_level;
+    }
+  }
+}
+
+/// @brief Checks the last level seen on the directly attached pin - including the edges held back by the debounce.
+/// @param pin 
+/// @return true if the button is known to be up, even when the click stacks did not get its release yet
+bool _buttonLooksReleased(int pin) {
+  for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+    if(btnPins[i] != pin) continue;
+    if(btnEdges[i].storming || btnEdges[i].polling) return btnEdges[i].level == SWbtns::UNCLICK;
+    return btnEdges[i].latest_level == SWbtns::UNCLICK;
+  }
+  return false;
+}
+
+/// @brief System-called function which is called when a click event was generated.
+/// Runs in the interrupt - so it lives in IRAM and only touches the preallocated edge queue. No heap, no Serial.
+/// @param pinNum 
+void IRAM_ATTR handleInterrupt(int pinNum) {
+  _btn_edges &edges = btnEdges[pinNum];
+  if(edges.storming) {
+    //the "tick" has not detached the interrupt yet
+    edges.dropped++;
+    return;
+  }
+  unsigned long pressedTime = _isrMillis();
+  uint8_t level = (_isrReadPin(edges.pin) == LOW) ? SWbtns::CLICK : SWbtns::UNCLICK;
+  edges.latest_level = level;
+  edges.latest_time = pressedTime;
+  // The edge rate is counted before the debounce - a bouncing switch is exactly what we are looking for.
+  if(pressedTime - edges.window_start >= CSWButtons::storm_window_ms) {
+    edges.window_start = pressedTime;
+    edges.window_edges = 0;
+  }
+  if(++edges.window_edges > CSWButtons::storm_edge_limit) {
+    edges.storming = true;
+    edges.dropped++;
+    return;
+  }
+  if(pressedTime - edges.last_edge_time < CSWButtons::button_debounce_ms) {
+    edges.debounced++;
+    return;
+  }
+  edges.last_edge_time = pressedTime;
+  uint8_t head = edges.head;
+  uint8_t next = (head + 1) % CSWBUTTONS_EDGE_QUEUE_SIZE;
+  if(next == edges.tail) {
+    //the "tick" did not come for too long - drop the edge
+    edges.dropped++;
+    return;
+  }
+  edges.edge_time[head] = pressedTime;
+  edges.edge_type[head] = level;
+  edges.head = next; //published last, so the "tick" never sees a half-written edge
 }
 
 //////////////////////////////////////////////////////////////////////////////
 /* The config of buttons lies actually here */
 
 #define PIN_HANDLER(pin) \
-extern void pin_handler_##pin (void) \
+void IRAM_ATTR pin_handler_##pin (void) \
 { \
-  unsigned long pressedTime = millis();\
-  if(pressedTime-lastPressedTime >= 100) {lastPressedTime=pressedTime;handleInterrupt(pin);} \
+  handleInterrupt(pin); \
 }
 
 /* YES I KNOW!!!!!!!!!!!!!
@@ -411,6 +874,99 @@ VoidFunctionWithNoParameters intrp_functions[] = {pin_handler_pinKey1,pin_handle
  * Oh, here we go - real end of bullsh*t
 */
 
+// Same story for the expanders: the INT line handler only marks the expander as changed, the read happens in the "tick".
+/// @brief Marks the expander as changed - its inputs are read by the next "tick"
+/// @param num 
+void IRAM_ATTR _expanderInterrupt(int num) {
+  if(!btnExpanders[num].pending) {
+    btnExpanders[num].int_time = _isrMillis();
+    btnExpanders[num].pending = true;
+  }
+}
+#define EXPANDER_HANDLER(num) \
+void IRAM_ATTR expander_handler_##num (void) \
+{ \
+  _expanderInterrupt(num); \
+}
+EXPANDER_HANDLER (0)
+EXPANDER_HANDLER (1)
+EXPANDER_HANDLER (2)
+EXPANDER_HANDLER (3)
+
+VoidFunctionWithNoParameters expander_intrp_functions[] = {expander_handler_0,expander_handler_1,expander_handler_2,expander_handler_3};
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief Interrupt-storm protection. A pin which got more than storm_edge_limit edges within storm_window_ms (worn or wet switch)
+/// gets its interrupt detached and is sampled every storm_poll_interval_ms through the debounce integrator instead.
+/// When the raw level has not changed for storm_settle_ms the interrupt is attached back. Called by the "tick" function.
+void _processStorms() {
+  unsigned long currTime = millis();
+  for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+    _btn_edges &edges = btnEdges[i];
+    if(!edges.storming) continue;
+    if(!edges.polling) {
+      #if defined(DEBUG) && DEBUG>=1
+      Serial.print("CSWBUTTONS: Interrupt storm on pin ");
+      Serial.print(edges.pin);
+      Serial.println(". Switching to polling.");
+      #endif
+      detachInterrupt(edges.pin);
+      edges.polling = true;
+      edges.raw_level = edges.level;
+      edges.integrator = (edges.level == SWbtns::CLICK) ? CSWBUTTONS_STORM_INTEGRATOR_MAX : 0;
+      edges.last_poll_time = currTime;
+      edges.last_raw_change = currTime;
+      continue;
+    }
+    if(currTime - edges.last_poll_time < CSWButtons::storm_poll_interval_ms) continue;
+    edges.last_poll_time = currTime;
+    uint8_t raw = (digitalRead(edges.pin) == LOW) ? SWbtns::CLICK : SWbtns::UNCLICK;
+    if(raw != edges.raw_level) {
+      edges.raw_level = raw;
+      edges.last_raw_change = currTime;
+    }
+    if(raw == SWbtns::CLICK) {
+      if(edges.integrator < CSWBUTTONS_STORM_INTEGRATOR_MAX) edges.integrator++;
+    } else {
+      if(edges.integrator > 0) edges.integrator--;
+    }
+    uint8_t level = edges.level;
+    if(edges.integrator == CSWBUTTONS_STORM_INTEGRATOR_MAX) level = SWbtns::CLICK;
+    else if(edges.integrator == 0) level = SWbtns::UNCLICK;
+    if(level != edges.level) {
+      edges.level = level;
+      btns.addEventToClickStack(edges.pin, level, currTime);
+    } else if(raw != level) {
+      edges.debounced++;
+    }
+    if(currTime - edges.last_raw_change >= CSWButtons::storm_settle_ms) {
+      #if defined(DEBUG) && DEBUG>=1
+      Serial.print("CSWBUTTONS: Pin ");
+      Serial.print(edges.pin);
+      Serial.println(" has settled. Attaching the interrupt back.");
+      #endif
+      edges.polling = false;
+      edges.window_start = currTime;
+      edges.window_edges = 0;
+      edges.last_edge_time = currTime;
+      edges.latest_level = edges.level;
+      edges.storming = false;
+      attachInterrupt (edges.pin, intrp_functions[i], CHANGE);
+    }
+  }
+}
+
+/// @brief Index of the directly attached button, -1 if there's no such pin
+/// @param pin 
+/// @return 
+int _btnEdgesIndex(int pin) {
+  for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+    if(btnPins[i] == pin) return i;
+  }
+  return -1;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 //the CSWButtons class functions bodies lie here.
@@ -422,6 +978,60 @@ void CSWButtons::addButton(int pin) {
   btnPins.push_back(pin);
 }
 
+/// @brief Adds the resistor-ladder keypad - a number of buttons on one ADC pin. Every band gets the logical button id, which is then used in onClick/onLongpress instead of the pin.
+/// @param adc_pin 
+/// @param thresholds the bands of the ladder, the order does not matter - they are sorted here
+/// @param count amount of the bands
+/// @param hysteresis how far (in ADC units) the value has to leave the band before the other band is taken
+void CSWButtons::addLadder(int adc_pin, const ladderThreshold * thresholds, int count, int hysteresis) {
+  if(count <= 0) return;
+  _btn_ladder ladder;
+  ladder.adc_pin = adc_pin;
+  ladder.hysteresis = hysteresis;
+  ladder.thresholds.assign(thresholds, thresholds + count);
+  std::sort(ladder.thresholds.begin(), ladder.thresholds.end(),
+    [](const ladderThreshold &a, const ladderThreshold &b) { return a.adc_max < b.adc_max; });
+  btnLadders.push_back(ladder);
+}
+
+/// @brief Adds the I2C GPIO expander (PCF8574/PCF8575/MCP23017) with the buttons on its pins. The INT line of the expander is the only interrupt used by it.
+/// Pin N of the expander is the logical button first_button+N for onClick/onLongpress.
+/// @param int_pin the pin where the INT line of the expander is connected
+/// @param i2c_address 
+/// @param expander_type one of the EXPANDER_* constants
+/// @param first_button 
+/// @param read_function custom reader of the inputs (e.g. a mock); by default Wire is used
+void CSWButtons::addExpander(int int_pin, uint8_t i2c_address, int expander_type, int first_button, ExpanderReadFunction read_function) {
+  if(btnExpandersCount >= CSWBUTTONS_MAX_EXPANDERS) return;
+  _btn_expander &expander = btnExpanders[btnExpandersCount];
+  expander.int_pin = int_pin;
+  expander.i2c_address = i2c_address;
+  expander.expander_type = expander_type;
+  expander.first_button = first_button;
+  expander.read_function = read_function ? read_function : _expanderWireRead;
+  btnExpandersCount++;
+}
+
+/// @brief Feeds the press/release of the button from outside of the library (host backends, custom drivers) into the click recognition.
+/// @param pin the pin or the logical button id used in onClick/onLongpress
+/// @param pressed 
+/// @param ts the time of the edge in ms on the library clock (see getTimems())
+void CSWButtons::pushEvent(int pin, bool pressed, unsigned long ts) {
+  btns.addEventToClickStack(pin, pressed ? SWbtns::CLICK : SWbtns::UNCLICK, ts);
+}
+
+/// @brief The same with the edge happening now
+void CSWButtons::pushEvent(int pin, bool pressed) {
+  this->pushEvent(pin, pressed, millis());
+}
+
+/// @brief The library clock in ms: millis() on Arduino, CLOCK_MONOTONIC since the start of the program on the host.
+/// The backends feeding pushEvent() with their own timestamps convert them to this scale.
+/// @return 
+unsigned long CSWButtons::getTimems() {
+  return millis();
+}
+
 void CSWButtons::onClick(int pin, VoidFunctionWithOneParameter onclick_function, int click_count) {
   btns.onclick(pin, onclick_function, click_count);
 }
@@ -430,6 +1040,54 @@ void CSWButtons::onLongpress(int pin, VoidFunctionWithOneParameter onclick_funct
   btns.onlongpress(pin, onclick_function);
 }
 
+/// @brief Hold tiers: onhold_function(pin, tier) is called while the button is still down, once for every tier reached (e.g. 500, 2000, 5000 ms).
+/// When any tier was reached the release does not produce the click or longpress.
+/// @param pin 
+/// @param tiers_ms 
+/// @param count 
+/// @param onhold_function 
+void CSWButtons::onHold(int pin, const int * tiers_ms, int count, VoidFunctionWithTwoParameters onhold_function) {
+  btns.onhold(pin, tiers_ms, count, onhold_function);
+}
+
+/// @brief onprogress_function(pin, held_ms) is called every interval_ms while the button is down and there are hold tiers left - e.g. for the fill animation.
+/// @param pin 
+/// @param onprogress_function 
+/// @param interval_ms 
+void CSWButtons::onHoldProgress(int pin, VoidFunctionWithTwoParameters onprogress_function, int interval_ms) {
+  btns.onholdprogress(pin, onprogress_function, interval_ms);
+}
+
+/// @brief Coalescing mode for the pin: instead of the click/multiclick/longpress recognition every press is counted at once
+/// and onclick_function(pin, count) gets all of the presses gathered since its previous call. The presses coming while it is
+/// still running (e.g. the ePaper refresh) are folded into one next call - the application renders once with the final position.
+/// With onclick_function == NULL the presses are kept until takePendingClicks() is called.
+/// @param pin 
+/// @param onclick_function 
+void CSWButtons::onCoalescedClick(int pin, VoidFunctionWithTwoParameters onclick_function) {
+  btns.oncoalescedclick(pin, onclick_function);
+}
+
+/// @brief Takes the presses gathered in the coalescing mode and not handed to the application yet
+/// @param pin 
+/// @return 
+int CSWButtons::takePendingClicks(int pin) {
+  return btns.takePendingClicks(pin);
+}
+
+/// @brief Typematic auto-repeat: after delay_ms of holding, onrepeat_function(pin, seq) is called every interval_ms, each interval being accel_percent of the previous one, down to min_interval_ms.
+/// The repeats follow their own schedule, not the tick rate: if the tick was late, the function is called once with seq advanced by all of the missed repeats,
+/// so the handler can move by the difference and redraw once. When any repeat was fired the release does not produce the click or longpress.
+/// @param pin 
+/// @param onrepeat_function 
+/// @param delay_ms 
+/// @param interval_ms 
+/// @param min_interval_ms 
+/// @param accel_percent 
+void CSWButtons::onRepeat(int pin, VoidFunctionWithTwoParameters onrepeat_function, int delay_ms, int interval_ms, int min_interval_ms, int accel_percent) {
+  btns.onrepeat(pin, onrepeat_function, delay_ms, interval_ms, min_interval_ms, accel_percent);
+}
+
 bool CSWButtons::checkEventsBlocked() {
   return _firstRun || _eventsBlocked;
 }
@@ -450,6 +1108,76 @@ void CSWButtons::setButtonRecheckIntervalms(int i) {
   CSWButtons::button_recheck_interval_ms=i;
 }
 
+void CSWButtons::setLadderSampleIntervalms(int i) {
+  CSWButtons::ladder_sample_interval_ms=i;
+}
+
+/// @brief Amount of the samples in a row the ladder value has to stay in the new band before it is taken
+/// @param n 
+void CSWButtons::setLadderStableSamples(int n) {
+  CSWButtons::ladder_stable_samples=n;
+}
+
+/// @brief Signals the INT line of the expander(s) on int_pin, the same as its interrupt does. For the INT line which is not
+/// connected to the interrupt-capable pin (polled by the sketch, or a mocked device on the host).
+/// @param int_pin 
+void CSWButtons::signalExpanderInterrupt(int int_pin) {
+  for(int i=0;i<btnExpandersCount;i++) {
+    if(btnExpanders[i].int_pin == int_pin) _expanderInterrupt(i);
+  }
+}
+
+/// @brief Replaces the provider of the wake cause (e.g. with a stub on the host). It is asked once in attachInterrupts().
+/// @param wake_function 
+void CSWButtons::setWakeCauseFunction(WakeCauseFunction wake_function) {
+  wakeCauseFunction = wake_function;
+}
+
+/// @brief The pin configured for the ext0 wakeup - the ESP32 does not tell which one it was.
+/// @param pin 
+void CSWButtons::setWakeExt0Pin(int pin) {
+  wakeExt0Pin = pin;
+}
+
+/// @brief Time from the wake by the button to the first callback of that button, -1 if there was no such wake or no callback yet
+/// @return 
+int CSWButtons::getWakeLatencyms() {
+  return wakeLatencyPending ? -1 : wakeLatency;
+}
+
+/// @brief Sets when the pin is considered to be storming: more than edge_limit edges within window_ms. After it the pin is polled every poll_interval_ms until it stays stable for settle_ms.
+/// @param edge_limit 
+/// @param window_ms 
+/// @param settle_ms 
+/// @param poll_interval_ms 
+void CSWButtons::setStormProtection(int edge_limit, int window_ms, int settle_ms, int poll_interval_ms) {
+  CSWButtons::storm_edge_limit=edge_limit;
+  CSWButtons::storm_window_ms=window_ms;
+  CSWButtons::storm_settle_ms=settle_ms;
+  CSWButtons::storm_poll_interval_ms=poll_interval_ms;
+}
+
+bool CSWButtons::isButtonStorming(int pin) {
+  int i = _btnEdgesIndex(pin);
+  return (i != -1) && btnEdges[i].storming;
+}
+
+/// @brief Amount of the edges of the pin which were lost - during the interrupt storm or because of the full edge queue
+/// @param pin 
+/// @return 
+uint32_t CSWButtons::getDroppedEvents(int pin) {
+  int i = _btnEdgesIndex(pin);
+  return (i != -1) ? btnEdges[i].dropped : 0;
+}
+
+/// @brief Amount of the edges of the pin which were folded by the debounce or by the polling integrator
+/// @param pin 
+/// @return 
+uint32_t CSWButtons::getDebouncedEdges(int pin) {
+  int i = _btnEdgesIndex(pin);
+  return (i != -1) ? btnEdges[i].debounced : 0;
+}
+
 
 /// @brief This has to be called after all of the buttons are added to the object. It attaches the necessary system interrupts so the click events will work. It should NOT be called more than once!
 void CSWButtons::attachInterrupts() {
@@ -458,13 +1186,24 @@ void CSWButtons::attachInterrupts() {
   Serial.println("CSWBUTTONS: First run set.");
   #endif
   btns.setEventsBlocked(true);
+  int wake_time = 0;
+  uint64_t wake_mask = wakeCauseFunction ? wakeCauseFunction(&wake_time) : 0;
   #if defined(DEBUG) && DEBUG>=10
   Serial.println("CSWBUTTONS: Events blocked set. Going to pinmodes...");
   Serial.print("CSWBUTTONS: Buttons numer is: ");
   Serial.println(btnPins.size());
   #endif
-  for(int i=0;i<btnPins.size();i++) {
+  for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+    btnEdges[i].pin = btnPins[i];
+    btnEdges[i].head = 0;
+    btnEdges[i].tail = 0;
+    btnEdges[i].storming = false;
+    btnEdges[i].polling = false;
     pinMode(btnPins[i], INPUT_PULLUP);
+    // read before the interrupt is attached - any later release comes as the usual edge
+    btnEdges[i].level = (digitalRead(btnPins[i]) == LOW) ? SWbtns::CLICK : SWbtns::UNCLICK;
+    btnEdges[i].latest_level = btnEdges[i].level;
+    btnEdges[i].last_edge_time = millis() - CSWButtons::button_debounce_ms;
     #if defined(DEBUG) && DEBUG>=10
     Serial.print("CSWBUTTONS: Pinmode for the pin ");
     Serial.print(btnPins[i]);
@@ -478,9 +1217,52 @@ void CSWButtons::attachInterrupts() {
     #endif
     btns.Add_btn(btnPins[i],i);
   }
+  for(int i=0;i<btnLadders.size();i++) {
+    pinMode(btnLadders[i].adc_pin, INPUT);
+    btnLadders[i].active = -1;
+    btnLadders[i].candidate_samples = 0;
+  }
+  // The expander keeps its INT line low until it is read, so the interrupt is attached first and the snapshot is taken
+  // by the first tick: a change right before the attach, or a failed read, would otherwise leave the line low with no falling edge to come.
+  for(int i=0;i<btnExpandersCount;i++) {
+    _expanderInit(btnExpanders[i]);
+    btnExpanders[i].synced = false;
+    for(int bit=0;bit<16;bit++) btnExpanders[i].edge_time[bit] = millis() - CSWButtons::button_debounce_ms;
+    pinMode(btnExpanders[i].int_pin, INPUT_PULLUP);
+    attachInterrupt (btnExpanders[i].int_pin, expander_intrp_functions[i], FALLING);
+    btnExpanders[i].int_time = millis();
+    btnExpanders[i].pending = true;
+  }
   btns.setEventsBlocked(false);
+  if(wake_mask) {
+    // The press which woke the chip started before anything was running - seed the click stack with it
+    // at the wake time. If the button was already let go, nobody knows when: booting may take longer than
+    // the longpress interval, so the release is put at the wake time too - such a wake press is a click.
+    // The latency is only taken when a press was seeded, and only from a callback of the pin which woke the chip.
+    wakePins = 0;
+    for(int i=0;i<btnPins.size() && i<CSWBUTTONS_MAX_BUTTONS;i++) {
+      if((btnPins[i] >= 64) || !(wake_mask & (1ULL << btnPins[i]))) continue;
+      #if defined(DEBUG) && DEBUG>=1
+      Serial.print("CSWBUTTONS: Woken up by the pin ");
+      Serial.println(btnPins[i]);
+      #endif
+      btns.addEventToClickStack(btnPins[i], SWbtns::CLICK, wake_time);
+      if(btnEdges[i].level == SWbtns::UNCLICK) btns.addEventToClickStack(btnPins[i], SWbtns::UNCLICK, wake_time);
+      wakePins |= 1ULL << btnPins[i];
+    }
+    if(wakePins) {
+      wakeTime = wake_time;
+      wakeLatencyPending = true;
+    }
+  }
 }
 void CSWButtons::tickTimer() {
+  _processEdges();
+  _processStorms();
+  _processLadders();
+  _processExpanders();
+  btns.processHolds();
+  btns.processCoalesced();
   btns.processStack();
 }
 
@@ -495,6 +1277,9 @@ void SWbtns::addEventToClickStack(int pin,int click_type, int ts) {
   #endif
   int indx_alt = this->getClickStackIndex(pin, true);
   if(this->checkEventsBlocked()) return;
+  int currTime = ts;
+  this->trackHold(pin, click_type, currTime);
+  if(this->coalesceEvent(pin, click_type)) return;
   bool is_alt=buttonsClickStackLocked;
   //if events are currently being processed for the current stack type (main or alt)
   bool ckst = this->checkClickStackDone(pin, is_alt); //optimization - less calls
@@ -523,7 +1308,6 @@ void SWbtns::addEventToClickStack(int pin,int click_type, int ts) {
   }
   // At this point the stack is NOT done (two previous "if's" are responsible for that).
   // So we can add to the current stack the event
-  int currTime = millis();
   t_buttonsStack * buttons_stack = &buttonsClickStack;
   if(is_alt) buttons_stack = &buttonsClickStackAlt;
   int btn_s_indx = this->getClickStackIndex(pin, is_alt);
@@ -541,7 +1325,7 @@ void SWbtns::addEventToClickStack(int pin,int click_type, int ts) {
       buttonsClickStackAlt.push_back(newButtonEventsStack);
     else
       buttonsClickStack.push_back(newButtonEventsStack);
-    btn_s_indx = 0;
+    btn_s_indx = (*buttons_stack).size() - 1;
   }
   t_buttonClickStackEvents stack = (*buttons_stack)[btn_s_indx].buttonClickStackEvents;
   if((stack.size() == 0) || (stack[stack.size()-1].is_complete)) {
@@ -672,7 +1456,7 @@ void SWbtns::swapClickStacks(int pin) {
       newButtonEventsStack.PIN = pin;
       newButtonEventsStack.buttonClickStackEvents = {};
       buttonsClickStack.push_back(newButtonEventsStack);
-      indx = 0;
+      indx = buttonsClickStack.size() - 1;
       buttonsClickStack[indx].buttonClickStackEvents = buttonsClickStackAlt[indx_alt].buttonClickStackEvents;
     } else {
       //if the alt buffer exists and the main is incomplete
@@ -719,6 +1503,7 @@ void SWbtns::processStack(void) {
   }
   for(buttonEventsStack buttons_stack_el : buttonsClickStack) {
     int pin = buttons_stack_el.PIN;
+    if(this->holdBlocksClick(pin)) continue;
     int indx = this->getClickStackIndex(pin, false);
     int indx_alt = this->getClickStackIndex(pin, true);
     if((indx_alt != -1) && (buttonsClickStackAlt[indx_alt].buttonClickStackEvents.size() > 0)) {
@@ -782,4 +1567,224 @@ void SWbtns::processStack(void) {
   }
   buttonsClickStackLocked = false;
   buttonsClickStackAltLocked = false;
-}
\ No newline at end of file
+}
+/// @brief Index of the hold settings of the pin, -1 if there are none
+/// @param pin 
+/// @param create add the empty settings if there are none
+/// @return 
+int SWbtns::getHoldIndex(int pin, bool create) {
+  for(int i=0; i<holdButtons.size();i++) {
+    if(holdButtons[i].pin == pin) return i;
+  }
+  if(!create) return -1;
+  _btn_hold hold;
+  hold.pin = pin;
+  holdButtons.push_back(hold);
+  return holdButtons.size() - 1;
+}
+
+void SWbtns::onhold(int pin, const int * tiers_ms, int count, VoidFunctionWithTwoParameters onhold_function) {
+  _btn_hold &hold = holdButtons[this->getHoldIndex(pin, true)];
+  hold.tiers.assign(tiers_ms, tiers_ms + max(count, 0));
+  std::sort(hold.tiers.begin(), hold.tiers.end());
+  hold.hold_function = onhold_function;
+}
+
+void SWbtns::onholdprogress(int pin, VoidFunctionWithTwoParameters onprogress_function, int interval_ms) {
+  _btn_hold &hold = holdButtons[this->getHoldIndex(pin, true)];
+  hold.progress_function = onprogress_function;
+  hold.progress_interval_ms = max(interval_ms, 1);
+}
+
+void SWbtns::onrepeat(int pin, VoidFunctionWithTwoParameters onrepeat_function, int delay_ms, int interval_ms, int min_interval_ms, int accel_percent) {
+  _btn_hold &hold = holdButtons[this->getHoldIndex(pin, true)];
+  hold.repeat_function = onrepeat_function;
+  hold.repeat_delay_ms = max(delay_ms, 0);
+  hold.repeat_interval_ms = max(interval_ms, 1);
+  hold.repeat_min_interval_ms = max(min(min_interval_ms, hold.repeat_interval_ms), 1);
+  hold.repeat_accel_percent = min(max(accel_percent, 1), 100);
+}
+
+/// @brief Follows the press/release of the buttons with the hold settings. Called for every click/unclick event.
+/// @param pin 
+/// @param click_type 
+/// @param ts 
+void SWbtns::trackHold(int pin, int click_type, int ts) {
+  int indx = this->getHoldIndex(pin);
+  if(indx == -1) return;
+  _btn_hold &hold = holdButtons[indx];
+  if(click_type == CLICK) {
+    if(hold.held) return;
+    hold.held = true;
+    hold.consumed = false;
+    hold.time_pressed = ts;
+    hold.next_tier = 0;
+    hold.next_progress = hold.progress_interval_ms;
+    hold.next_repeat = hold.repeat_delay_ms;
+    hold.repeat_curr_interval = hold.repeat_interval_ms;
+    hold.repeat_seq = 0;
+  } else {
+    hold.held = false;
+  }
+  this->scheduleHolds();
+}
+
+/// @brief The next moment (ms) when something has to be fired for the held button
+/// @param hold 
+/// @param deadline 
+/// @return false if nothing is left to fire
+bool SWbtns::getHoldDeadline(const _btn_hold &hold, int * deadline) {
+  if(!hold.held) return false;
+  bool tiers_left = hold.next_tier < hold.tiers.size();
+  bool found = false;
+  int d = 0;
+  if(tiers_left && hold.hold_function) {
+    d = hold.tiers[hold.next_tier];
+    found = true;
+  }
+  if(hold.progress_function && (tiers_left || hold.tiers.size() == 0)) {
+    if(!found || hold.next_progress < d) d = hold.next_progress;
+    found = true;
+  }
+  if(hold.repeat_function) {
+    if(!found || hold.next_repeat < d) d = hold.next_repeat;
+    found = true;
+  }
+  if(found) *deadline = hold.time_pressed + d;
+  return found;
+}
+
+/// @brief Finds the nearest deadline of all of the held buttons
+void SWbtns::scheduleHolds(void) {
+  holdDeadlineArmed = false;
+  for(int i=0;i<holdButtons.size();i++) {
+    int deadline;
+    if(!this->getHoldDeadline(holdButtons[i], &deadline)) continue;
+    if(!holdDeadlineArmed || (deadline - holdNextDeadline < 0)) holdNextDeadline = deadline;
+    holdDeadlineArmed = true;
+  }
+}
+
+/// @brief Fires the hold tiers and progress callbacks which are due. Called by the "tick" function - costs one comparison until the nearest deadline.
+void SWbtns::processHolds(void) {
+  if(!holdDeadlineArmed) return;
+  int currTime = millis();
+  if(currTime - holdNextDeadline < 0) return;
+  for(int i=0;i<holdButtons.size();i++) {
+    if(!holdButtons[i].held) continue;
+    int pin = holdButtons[i].pin;
+    int held_ms = currTime - holdButtons[i].time_pressed;
+    // the release may still be held back by the debounce - a quick tap must not fire the hold tiers or repeats
+    bool released = _buttonLooksReleased(pin);
+    if(!released && holdButtons[i].progress_function && (holdButtons[i].next_progress <= held_ms)
+    && ((holdButtons[i].next_tier < holdButtons[i].tiers.size()) || (holdButtons[i].tiers.size() == 0))) {
+      //the late tick fires it once and goes to the next interval in the future - no catching up
+      int interval = holdButtons[i].progress_interval_ms;
+      holdButtons[i].next_progress += ((held_ms - holdButtons[i].next_progress) / interval + 1) * interval;
+      _wakeCallbackFired(pin);
+      holdButtons[i].progress_function(pin, held_ms);
+    }
+    if(!released && holdButtons[i].repeat_function && (holdButtons[i].next_repeat <= held_ms)) {
+      //every missed repeat still moves the schedule and the sequence number, the function is called once
+      while(holdButtons[i].next_repeat <= held_ms) {
+        holdButtons[i].repeat_seq++;
+        holdButtons[i].next_repeat += holdButtons[i].repeat_curr_interval;
+        holdButtons[i].repeat_curr_interval = max(holdButtons[i].repeat_min_interval_ms, holdButtons[i].repeat_curr_interval * holdButtons[i].repeat_accel_percent / 100);
+      }
+      holdButtons[i].consumed = true;
+      _wakeCallbackFired(pin);
+      holdButtons[i].repeat_function(pin, holdButtons[i].repeat_seq);
+    }
+    // the callbacks may add the hold settings, so the element is taken by index every time
+    while(!released && holdButtons[i].hold_function && (holdButtons[i].next_tier < holdButtons[i].tiers.size())
+    && (holdButtons[i].tiers[holdButtons[i].next_tier] <= held_ms)) {
+      int tier = holdButtons[i].next_tier++;
+      holdButtons[i].consumed = true;
+      #if defined(DEBUG) && DEBUG>=1
+      Serial.print("CSWBUTTONS: HOLD tier ");
+      Serial.print(tier);
+      Serial.print(" reached. PIN: ");
+      Serial.println(pin);
+      #endif
+      _wakeCallbackFired(pin);
+      holdButtons[i].hold_function(pin, tier);
+    }
+  }
+  this->scheduleHolds();
+}
+
+/// @brief The click stack of the held button is not processed until the release. If a hold tier was fired, the gesture is over - the stack is dropped without the click/longpress.
+/// @param pin 
+/// @return true if the click stack of the pin has to be skipped
+bool SWbtns::holdBlocksClick(int pin) {
+  int indx = this->getHoldIndex(pin);
+  if(indx == -1) return false;
+  _btn_hold &hold = holdButtons[indx];
+  if(hold.held && (hold.hold_function || hold.progress_function || hold.repeat_function)) return true;
+  if(hold.consumed) {
+    hold.consumed = false;
+    this->clearClickStack(pin, false);
+    this->clearClickStack(pin, true);
+    return true;
+  }
+  return false;
+}
+
+/// @brief Index of the coalescing settings of the pin, -1 if the pin is not in the coalescing mode
+/// @param pin 
+/// @param create 
+/// @return 
+int SWbtns::getCoalescedIndex(int pin, bool create) {
+  for(int i=0; i<coalescedButtons.size();i++) {
+    if(coalescedButtons[i].pin == pin) return i;
+  }
+  if(!create) return -1;
+  _btn_coalesced coalesced;
+  coalesced.pin = pin;
+  coalescedButtons.push_back(coalesced);
+  return coalescedButtons.size() - 1;
+}
+
+void SWbtns::oncoalescedclick(int pin, VoidFunctionWithTwoParameters onclick_function) {
+  coalescedButtons[this->getCoalescedIndex(pin, true)].event_function = onclick_function;
+}
+
+/// @brief Counts the press of the pin in the coalescing mode.
+/// @param pin 
+/// @param click_type 
+/// @return true if the pin is in the coalescing mode - the event does not go to the click stack then
+bool SWbtns::coalesceEvent(int pin, int click_type) {
+  int indx = this->getCoalescedIndex(pin);
+  if(indx == -1) return false;
+  if(click_type == CLICK) coalescedButtons[indx].pending++;
+  return true;
+}
+
+int SWbtns::takePendingClicks(int pin) {
+  int indx = this->getCoalescedIndex(pin);
+  if(indx == -1) return 0;
+  int pending = coalescedButtons[indx].pending;
+  coalescedButtons[indx].pending = 0;
+  return pending;
+}
+
+/// @brief Hands the gathered presses to the application. Called by the "tick" function. Skips the pin whose function is still running
+/// (the tick may be called from inside of it), so the presses keep folding into the next call.
+void SWbtns::processCoalesced(void) {
+  for(int i=0;i<coalescedButtons.size();i++) {
+    if(coalescedButtons[i].busy || !coalescedButtons[i].event_function || (coalescedButtons[i].pending == 0)) continue;
+    int pin = coalescedButtons[i].pin;
+    int pending = coalescedButtons[i].pending;
+    coalescedButtons[i].pending = 0;
+    coalescedButtons[i].busy = true;
+    #if defined(DEBUG) && DEBUG>=1
+    Serial.print("CSWBUTTONS: COALESCED clicks: ");
+    Serial.print(pending);
+    Serial.print("; PIN: ");
+    Serial.println(pin);
+    #endif
+    _wakeCallbackFired(pin);
+    coalescedButtons[i].event_function(pin, pending);
+    coalescedButtons[i].busy = false;
+  }
+}
@@ -28,6 +28,9 @@ struct qButton {
 
 typedef void (*VoidFunctionWithNoParameters) (void);
 typedef void (*VoidFunctionWithOneParameter) (int);
+typedef void (*VoidFunctionWithTwoParameters) (int, int);
+typedef uint64_t (*WakeCauseFunction) (int * wake_time_ms);
+typedef bool (*ExpanderReadFunction) (uint8_t i2c_address, int expander_type, uint16_t * inputs);
 
 struct buttonClickStackEvent {
   int time_pressed=-1;
@@ -41,22 +44,58 @@ struct buttonEventsStack {
 };
 typedef std::vector<buttonEventsStack> t_buttonsStack;
 
+/// @brief One band of the resistor-ladder keypad: every ADC reading up to (and including) adc_max which is above the previous band belongs to the logical button.
+struct ladderThreshold {
+  int adc_max;
+  int button;
+};
+
 class CSWButtons{
   public:
     CSWButtons();
     void addButton(int pin);
+    void addLadder(int adc_pin, const ladderThreshold * thresholds, int count, int hysteresis=40);
+    void addExpander(int int_pin, uint8_t i2c_address, int expander_type, int first_button, ExpanderReadFunction read_function=__null);
+    void signalExpanderInterrupt(int int_pin);
     void attachInterrupts(void);
+    void pushEvent(int pin, bool pressed);
+    void pushEvent(int pin, bool pressed, unsigned long ts);
+    unsigned long getTimems(void);
     void tickTimer(void);
     bool checkEventsBlocked(void);
     void setEventsBlocked(bool v);
     void onLongpress(int pin, VoidFunctionWithOneParameter onclick_function);
     void onClick(int pin, VoidFunctionWithOneParameter onclick_function, int click_count=-1);
+    void onHold(int pin, const int * tiers_ms, int count, VoidFunctionWithTwoParameters onhold_function);
+    void onHoldProgress(int pin, VoidFunctionWithTwoParameters onprogress_function, int interval_ms=50);
+    void onCoalescedClick(int pin, VoidFunctionWithTwoParameters onclick_function);
+    int takePendingClicks(int pin);
+    void onRepeat(int pin, VoidFunctionWithTwoParameters onrepeat_function, int delay_ms=400, int interval_ms=200, int min_interval_ms=40, int accel_percent=80);
     void setButtonClickFlowFimit(int l);
     void setButtonLongpressIntervalms(int i);
     void setButtonRecheckIntervalms(int i);
+    void setLadderSampleIntervalms(int i);
+    void setLadderStableSamples(int n);
+    void setWakeCauseFunction(WakeCauseFunction wake_function);
+    void setWakeExt0Pin(int pin);
+    int getWakeLatencyms(void);
+    void setStormProtection(int edge_limit, int window_ms, int settle_ms=1000, int poll_interval_ms=20);
+    bool isButtonStorming(int pin);
+    uint32_t getDroppedEvents(int pin);
+    uint32_t getDebouncedEdges(int pin);
     static int button_recheck_interval_ms;
     static int button_click_flow_limit;
     static int button_recheck_interval_longpress_ms;
+    static int ladder_sample_interval_ms;
+    static int ladder_stable_samples;
+    static int button_debounce_ms;
+    static int storm_edge_limit;
+    static int storm_window_ms;
+    static int storm_poll_interval_ms;
+    static int storm_settle_ms;
+    const static int EXPANDER_PCF8574=0;
+    const static int EXPANDER_PCF8575=1;
+    const static int EXPANDER_MCP23017=2;
   private:
     int _button_pin=-1;
     bool _firstRun=true;
@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    CSWButtonsGpiod.cpp
+  * @author  Eugene at sky.community
+  * @version V1.0.0
+  * @date    12-December-2022
+  * @brief   Linux backend: the buttons on the GPIO character device (/dev/gpiochipN), uAPI v2.
+  *
+  ******************************************************************************
+  */
+
+#include "CSWButtonsGpiod.h"
+#if defined(__linux__) && !defined(ARDUINO)
+using namespace swbtns;
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+// How many kernel events are taken by one read() call.
+#define CSWBUTTONS_GPIOD_EVENTS_BATCH 16
+
+CSWButtonsGpiod::CSWButtonsGpiod(CSWButtons &buttons) : _buttons(buttons) {
+}
+
+CSWButtonsGpiod::~CSWButtonsGpiod() {
+  end();
+}
+
+/// @brief Requests the lines of the chip as inputs with both edges detected and the kernel debounce.
+/// Line N of the chip is the logical button first_button+N for onClick/onLongpress - so the lines of several chips, ladders and expanders do not collide.
+/// @param chip_path e.g. "/dev/gpiochip0"
+/// @param offsets 
+/// @param count 
+/// @param first_button 
+/// @param debounce_us kernel debounce period, 0 - no debounce
+/// @param active_low the button pulls the line LOW when pressed
+/// @return false if the lines could not be requested
+bool CSWButtonsGpiod::begin(const char * chip_path, const unsigned int * offsets, int count, int first_button, int debounce_us, bool active_low) {
+  end();
+  if((count <= 0) || (count > GPIO_V2_LINES_MAX)) return false;
+  int chip_fd = open(chip_path, O_RDONLY | O_CLOEXEC);
+  if(chip_fd < 0) return false;
+  struct gpio_v2_line_request req;
+  memset(&req, 0, sizeof(req));
+  for(int i=0;i<count;i++) req.offsets[i] = offsets[i];
+  req.num_lines = count;
+  strncpy(req.consumer, "CSWButtons", sizeof(req.consumer) - 1);
+  req.event_buffer_size = count * CSWBUTTONS_GPIOD_EVENTS_BATCH;
+  req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+  // With ACTIVE_LOW the kernel reports the edges on the logical level - rising edge is the press.
+  if(active_low) req.config.flags |= GPIO_V2_LINE_FLAG_ACTIVE_LOW | GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+  if(debounce_us > 0) {
+    req.config.num_attrs = 1;
+    req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+    req.config.attrs[0].attr.debounce_period_us = debounce_us;
+    req.config.attrs[0].mask = (count == 64) ? ~0ULL : ((1ULL << count) - 1);
+  }
+  int ret = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+  close(chip_fd);
+  if(ret < 0) return false;
+  attachFd(req.fd, first_button);
+  _ownFd = true;
+  return true;
+}
+
+/// @brief Uses the already requested line fd - or anything giving struct gpio_v2_line_event records, e.g. a pipe in the tests. The fd is not closed by end().
+/// @param fd 
+/// @param first_button the logical button of line 0, see begin()
+void CSWButtonsGpiod::attachFd(int fd, int first_button) {
+  end();
+  _fd = fd;
+  _firstButton = first_button;
+  _ownFd = false;
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+}
+
+void CSWButtonsGpiod::end() {
+  if(_ownFd && (_fd >= 0)) close(_fd);
+  _fd = -1;
+  _ownFd = false;
+}
+
+/// @brief The fd to wait on (poll/select/epoll) in the application main loop
+/// @return 
+int CSWButtonsGpiod::getFd() {
+  return _fd;
+}
+
+/// @brief Reads all of the pending edge events in batches and feeds them with their kernel timestamps into the click recognition. Never blocks.
+/// Has to be called before CSWButtons::tickTimer() in the main loop.
+/// @return amount of the events fed, -1 on the read error
+int CSWButtonsGpiod::poll() {
+  if(_fd < 0) return -1;
+  struct gpio_v2_line_event events[CSWBUTTONS_GPIOD_EVENTS_BATCH];
+  int fed = 0;
+  while(true) {
+    ssize_t rd = read(_fd, events, sizeof(events));
+    if(rd < 0) {
+      if(errno == EINTR) continue;
+      if((errno == EAGAIN) || (errno == EWOULDBLOCK)) break;
+      return -1;
+    }
+    int n = rd / sizeof(struct gpio_v2_line_event);
+    // The kernel stamps the events with CLOCK_MONOTONIC since the boot. They are moved to the library clock by their age,
+    // so the click stacks get small times no matter how long the system is up.
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned long long now_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+    unsigned long now_ms = _buttons.getTimems();
+    for(int i=0;i<n;i++) {
+      unsigned long long age_ms = (now_ns > events[i].timestamp_ns) ? (now_ns - events[i].timestamp_ns) / 1000000ULL : 0;
+      unsigned long ts = (age_ms < now_ms) ? now_ms - age_ms : 0;
+      _buttons.pushEvent(_firstButton + events[i].offset, events[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE, ts);
+    }
+    fed += n;
+    if(rd < (ssize_t)sizeof(events)) break;
+  }
+  return fed;
+}
+
+#endif
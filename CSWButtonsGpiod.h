@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file    CSWButtonsGpiod.h
+  * @author  Eugene at sky.community
+  * @version V1.0.0
+  * @date    12-December-2022
+  * @brief   Linux backend: the buttons on the GPIO character device (/dev/gpiochipN), uAPI v2.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef CSWButtonsGpiod_h
+#define CSWButtonsGpiod_h
+#if defined(__linux__) && !defined(ARDUINO)
+#include "CSWButtons.h"
+
+namespace swbtns {
+
+class CSWButtonsGpiod{
+  public:
+    CSWButtonsGpiod(CSWButtons &buttons);
+    ~CSWButtonsGpiod();
+    bool begin(const char * chip_path, const unsigned int * offsets, int count, int first_button, int debounce_us=10000, bool active_low=true);
+    void attachFd(int fd, int first_button);
+    void end(void);
+    int poll(void);
+    int getFd(void);
+  private:
+    CSWButtons &_buttons;
+    int _fd=-1;
+    int _firstButton=0;
+    bool _ownFd=false;
+};
+}
+
+#endif
+#endif
@@ -0,0 +1,33 @@
+/**
+  ******************************************************************************
+  * @file    fake_pins.h
+  * @brief   Fake level of the directly attached button for the host tests. The test adds it first, on PIN.
+  *
+  ******************************************************************************
+  */
+
+#ifndef CSWButtons_fake_pins_h
+#define CSWButtons_fake_pins_h
+#include "test_common.h"
+
+#define PIN 4
+#define LOW 0
+#define HIGH 1
+
+// The interrupt handler of the first button, CSWButtons.cpp
+void pin_handler_pinKey1(void);
+
+static int pin_level = HIGH;
+
+/// @brief Overrides the weak host stub of CSWButtons.cpp
+int digitalRead(uint8_t pin) {
+  return (pin == PIN) ? pin_level : HIGH;
+}
+
+/// @brief The level of the pin changes and its interrupt comes
+static void setPin(int level) {
+  pin_level = level;
+  pin_handler_pinKey1();
+}
+
+#endif
@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    test_coalesce.cpp
+  * @brief   Coalescing mode: the presses coming during the slow handler are folded into one call.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+using namespace swbtns;
+
+#define BUTTON 20
+#define POLLED_BUTTON 21
+
+static CSWButtons buttons;
+static int calls = 0;
+static int counts[8];
+static int clicks = 0;
+static int longpresses = 0;
+
+/// @brief The press on the host comes through pushEvent(), like from a backend
+void tap(int button) {
+  buttons.pushEvent(button, true);
+  buttons.pushEvent(button, false);
+}
+
+/// @brief The slow redraw: the first call gets three more presses while it runs, and keeps the loop ticking
+void onCoalesced(int pin, int count) {
+  if(calls < 8) counts[calls] = count;
+  calls++;
+  if(calls == 1) {
+    for(int i=0;i<3;i++) {
+      tap(BUTTON);
+      tickFor(buttons, 20);
+    }
+  }
+}
+void onClk(int pin) { clicks++; }
+void onLngPrs(int pin) { longpresses++; }
+
+int main() {
+  buttons.onCoalescedClick(BUTTON, onCoalesced);
+  buttons.onClick(BUTTON, onClk, 1);
+  buttons.onClick(BUTTON, onClk, 2);
+  buttons.onLongpress(BUTTON, onLngPrs);
+  buttons.onCoalescedClick(POLLED_BUTTON, NULL);
+  buttons.onClick(POLLED_BUTTON, onClk, 1);
+  buttons.attachInterrupts();
+  tickFor(buttons, 50);
+
+  // One press - one call at once; the three presses during it - one more call with all of them.
+  tap(BUTTON);
+  tickFor(buttons, 150);
+  CHECK_EQ(calls, 2);
+  CHECK_EQ(counts[0], 1);
+  CHECK_EQ(counts[1], 3);
+
+  // A long hold is just one more press, neither the longpress nor the multiclick is recognized for the pin.
+  buttons.pushEvent(BUTTON, true);
+  tickFor(buttons, 700);
+  buttons.pushEvent(BUTTON, false);
+  tap(BUTTON);
+  tickFor(buttons, 1300);
+  CHECK_EQ(calls, 4);
+  CHECK_EQ(counts[2] + counts[3], 2);
+  CHECK_EQ(clicks, 0);
+  CHECK_EQ(longpresses, 0);
+
+  // Without the function the presses wait for takePendingClicks().
+  tap(POLLED_BUTTON);
+  tap(POLLED_BUTTON);
+  tickFor(buttons, 50);
+  tap(POLLED_BUTTON);
+  tickFor(buttons, 1300);
+  CHECK_EQ(buttons.takePendingClicks(POLLED_BUTTON), 3);
+  CHECK_EQ(buttons.takePendingClicks(POLLED_BUTTON), 0);
+  CHECK_EQ(buttons.takePendingClicks(BUTTON), 0);
+  CHECK_EQ(clicks, 0);
+  CHECK_EQ(calls, 4);
+
+  return testResult("test_coalesce");
+}
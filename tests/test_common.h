@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    test_common.h
+  * @brief   Helpers of the host tests.
+  *
+  ******************************************************************************
+  */
+
+#ifndef CSWButtons_test_common_h
+#define CSWButtons_test_common_h
+#include "CSWButtons.h"
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+  if(!(cond)) { \
+    fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+    test_failures++; \
+  } \
+} while(0)
+
+#define CHECK_EQ(a, b) do { \
+  long _a = (long)(a), _b = (long)(b); \
+  if(_a != _b) { \
+    fprintf(stderr, "%s:%d: CHECK failed: %s == %s (%ld vs %ld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+    test_failures++; \
+  } \
+} while(0)
+
+/// @brief Calls the "tick" of the buttons for ms milliseconds, the way the sketch loop does
+static void tickFor(swbtns::CSWButtons &buttons, int ms) {
+  struct timespec start, now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  do {
+    buttons.tickTimer();
+    usleep(2000);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  } while((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 < ms);
+}
+
+static int testResult(const char * name) {
+  if(test_failures) fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);
+  else printf("%s: OK\n", name);
+  return test_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    test_expander.cpp
+  * @brief   I2C expander backend against a mocked PCF8574.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+using namespace swbtns;
+
+#define INT_PIN 5
+#define FIRST_BUTTON 100
+
+static uint16_t mock_inputs = 0xFFFF;
+static int mock_reads = 0;
+static int mock_failing_reads = 1; //the bus is not ready yet at the start
+static bool mock_int_low = true; //the inputs changed at the power-up and nobody has read them yet
+static int clicks[4] = {0, 0, 0, 0};
+
+/// @brief Like the real device: the successful read releases the INT line
+bool mockRead(uint8_t i2c_address, int expander_type, uint16_t * inputs) {
+  if(i2c_address != 0x20) return false;
+  mock_reads++;
+  if(mock_failing_reads > 0) {
+    mock_failing_reads--;
+    return false;
+  }
+  *inputs = mock_inputs;
+  mock_int_low = false;
+  return true;
+}
+
+void onClk1(int pin) { if(pin == FIRST_BUTTON) clicks[1]++; }
+void onClk2(int pin) { if(pin == FIRST_BUTTON) clicks[2]++; }
+void onClk3(int pin) { if(pin == FIRST_BUTTON) clicks[3]++; }
+
+/// @brief The mocked device changes its inputs and pulls its INT line - the interrupt comes only on its falling edge
+void setInputs(CSWButtons &buttons, uint16_t inputs) {
+  mock_inputs = inputs;
+  if(mock_int_low) return;
+  mock_int_low = true;
+  buttons.signalExpanderInterrupt(INT_PIN);
+}
+
+int main() {
+  CSWButtons buttons;
+  buttons.addExpander(INT_PIN, 0x20, CSWButtons::EXPANDER_PCF8574, FIRST_BUTTON, mockRead);
+  buttons.onClick(FIRST_BUTTON, onClk1, 1);
+  buttons.onClick(FIRST_BUTTON, onClk2, 2);
+  buttons.onClick(FIRST_BUTTON, onClk3, 3);
+  // The button is held at the start: the snapshot is not its press.
+  mock_inputs = 0xFFFE;
+  buttons.attachInterrupts();
+  CHECK_EQ(mock_reads, 0);
+
+  // The snapshot is read by the tick after the interrupt is attached; the failed read is retried and releases the INT line.
+  tickFor(buttons, 50);
+  CHECK_EQ(mock_reads, 2);
+  CHECK(!mock_int_low);
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 1300);
+  CHECK_EQ(mock_reads, 3);
+  CHECK_EQ(clicks[1], 0);
+
+  // No INT - no bus traffic.
+  tickFor(buttons, 50);
+  CHECK_EQ(mock_reads, 3);
+
+  // One bouncy press: the bounces come within the debounce time and must not become the clicks.
+  setInputs(buttons, 0xFFFE);
+  tickFor(buttons, 5);
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 5);
+  setInputs(buttons, 0xFFFE);
+  tickFor(buttons, 5);
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 5);
+  setInputs(buttons, 0xFFFE);
+  tickFor(buttons, 150);
+  CHECK_EQ(mock_reads, 8); //one read per INT
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 1);
+  CHECK_EQ(clicks[2], 0);
+  CHECK_EQ(clicks[3], 0);
+
+  // The release lost in the bounce is delivered once the debounce time is over: a quick tap is still one click.
+  setInputs(buttons, 0xFFFE);
+  tickFor(buttons, 20);
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 2);
+
+  // The other inputs of the same expander do not disturb the button.
+  setInputs(buttons, 0xFFFD);
+  tickFor(buttons, 150);
+  setInputs(buttons, 0xFFFF);
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 2);
+
+  return testResult("test_expander");
+}
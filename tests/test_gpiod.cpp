@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    test_gpiod.cpp
+  * @brief   Linux GPIO character device backend fed by a pipe instead of the line request fd.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+#include "CSWButtonsGpiod.h"
+#include <linux/gpio.h>
+#include <string.h>
+#include <fcntl.h>
+using namespace swbtns;
+
+#define LINE 7
+#define CHIP2_FIRST_BUTTON 100
+
+static int clicks[3] = {0, 0, 0};
+static int longpresses = 0;
+static int chip2_clicks = 0;
+
+void onClk1(int pin) { if(pin == LINE) clicks[1]++; }
+void onClk2(int pin) { if(pin == LINE) clicks[2]++; }
+void onLngPrs(int pin) { if(pin == LINE) longpresses++; }
+void onChip2Clk(int pin) { if(pin == CHIP2_FIRST_BUTTON + LINE) chip2_clicks++; }
+
+unsigned long long monotonicNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/// @brief Writes the kernel-like edge event, stamped age_ms ago
+void writeEvent(int fd, bool rising, int age_ms) {
+  struct gpio_v2_line_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.timestamp_ns = monotonicNs() - age_ms * 1000000ULL;
+  ev.id = rising ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+  ev.offset = LINE;
+  CHECK(write(fd, &ev, sizeof(ev)) == sizeof(ev));
+}
+
+int main() {
+  CSWButtons buttons;
+  CSWButtonsGpiod gpiod(buttons);
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  gpiod.attachFd(fds[0], 0);
+  CHECK_EQ(gpiod.getFd(), fds[0]);
+  // The second chip has the line with the same offset.
+  CSWButtonsGpiod gpiod2(buttons);
+  int fds2[2];
+  CHECK(pipe(fds2) == 0);
+  gpiod2.attachFd(fds2[0], CHIP2_FIRST_BUTTON);
+  buttons.onClick(CHIP2_FIRST_BUTTON + LINE, onChip2Clk, 1);
+  buttons.onClick(LINE, onClk1, 1);
+  buttons.onClick(LINE, onClk2, 2);
+  buttons.onLongpress(LINE, onLngPrs);
+  buttons.attachInterrupts();
+
+  // Nothing pending - the read does not block.
+  CHECK_EQ(gpiod.poll(), 0);
+  tickFor(buttons, 500); //so the events below are not older than the library clock
+
+  // Double click, all four edges read in one batch.
+  writeEvent(fds[1], true, 400);
+  writeEvent(fds[1], false, 350);
+  writeEvent(fds[1], true, 200);
+  writeEvent(fds[1], false, 150);
+  CHECK_EQ(gpiod.poll(), 4);
+  tickFor(buttons, 1200);
+  CHECK_EQ(clicks[1], 0);
+  CHECK_EQ(clicks[2], 1);
+  CHECK_EQ(longpresses, 0);
+
+  // The kernel timestamps are used, not the time of the read: the press stamped 700 ms ago is a longpress.
+  writeEvent(fds[1], true, 700);
+  writeEvent(fds[1], false, 0);
+  CHECK_EQ(gpiod.poll(), 2);
+  tickFor(buttons, 1200);
+  CHECK_EQ(longpresses, 1);
+  CHECK_EQ(clicks[1], 0);
+
+  // The same offset on the second chip is its own button.
+  writeEvent(fds2[1], true, 100);
+  writeEvent(fds2[1], false, 50);
+  CHECK_EQ(gpiod2.poll(), 2);
+  CHECK_EQ(gpiod.poll(), 0);
+  tickFor(buttons, 1200);
+  CHECK_EQ(chip2_clicks, 1);
+  CHECK_EQ(clicks[1], 0);
+  CHECK_EQ(longpresses, 1);
+
+  // The pipe fd belongs to the test - end() does not close it.
+  gpiod.end();
+  CHECK_EQ(gpiod.getFd(), -1);
+  CHECK(fcntl(fds[0], F_GETFD) != -1);
+  close(fds[0]);
+  close(fds[1]);
+  gpiod2.end();
+  close(fds2[0]);
+  close(fds2[1]);
+
+  return testResult("test_gpiod");
+}
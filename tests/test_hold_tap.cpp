@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    test_hold_tap.cpp
+  * @brief   Hold tiers and a quick tap whose release edge is swallowed by the debounce.
+  *
+  ******************************************************************************
+  */
+
+#include "fake_pins.h"
+using namespace swbtns;
+
+static int tiers_fired = 0;
+static int clicks = 0;
+
+void onHld(int pin, int tier) { tiers_fired++; }
+void onClk(int pin) { clicks++; }
+
+int main() {
+  CSWButtons buttons;
+  const int tiers[] = {300, 600};
+  buttons.addButton(PIN);
+  buttons.onClick(PIN, onClk, 1);
+  buttons.onHold(PIN, tiers, 2, onHld);
+  buttons.attachInterrupts();
+  tickFor(buttons, 200);
+
+  // Quick tap: the release comes 30 ms after the press, within the 100 ms debounce - its interrupt does not queue the edge.
+  setPin(LOW);
+  tickFor(buttons, 30);
+  setPin(HIGH);
+  tickFor(buttons, 1300);
+  CHECK_EQ(tiers_fired, 0);
+  CHECK_EQ(clicks, 1);
+
+  // The tap did not leave the button "held": a real hold fires both tiers and no click.
+  setPin(LOW);
+  tickFor(buttons, 700);
+  CHECK_EQ(tiers_fired, 2);
+  setPin(HIGH);
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks, 1);
+
+  // And the next tap is a click again.
+  setPin(LOW);
+  tickFor(buttons, 150);
+  setPin(HIGH);
+  tickFor(buttons, 1300);
+  CHECK_EQ(tiers_fired, 2);
+  CHECK_EQ(clicks, 2);
+
+  return testResult("test_hold_tap");
+}
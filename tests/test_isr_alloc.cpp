@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    test_isr_alloc.cpp
+  * @brief   The interrupt path must not touch the heap.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+#include <new>
+#include <stdlib.h>
+using namespace swbtns;
+
+// The interrupt handlers of CSWButtons.cpp
+void handleInterrupt(int pinNum);
+void pin_handler_pinKey1(void);
+void pin_handler_pinKey2(void);
+void expander_handler_0(void);
+
+static bool count_allocations = false;
+static int allocations = 0;
+
+void * operator new(size_t size) {
+  if(count_allocations) allocations++;
+  void * p = malloc(size ? size : 1);
+  if(!p) throw std::bad_alloc();
+  return p;
+}
+void * operator new[](size_t size) {
+  return operator new(size);
+}
+void operator delete(void * p) noexcept { free(p); }
+void operator delete[](void * p) noexcept { free(p); }
+void operator delete(void * p, size_t) noexcept { free(p); }
+void operator delete[](void * p, size_t) noexcept { free(p); }
+
+bool mockRead(uint8_t i2c_address, int expander_type, uint16_t * inputs) {
+  *inputs = 0xFFFF;
+  return true;
+}
+
+void onClk(int pin) {
+}
+
+int main() {
+  CSWButtons buttons;
+  buttons.addButton(4);
+  buttons.addButton(5);
+  buttons.addExpander(6, 0x20, CSWButtons::EXPANDER_PCF8574, 100, mockRead);
+  buttons.onClick(4, onClk, 1);
+  buttons.attachInterrupts();
+  tickFor(buttons, 10);
+
+  // Every branch of the handler: queued edges, queue overflow (no tick in between), debounce, storm.
+  count_allocations = true;
+  CSWButtons::button_debounce_ms = 0;
+  for(int i=0;i<20;i++) pin_handler_pinKey1();
+  CSWButtons::button_debounce_ms = 100;
+  for(int i=0;i<50;i++) pin_handler_pinKey2();
+  for(int i=0;i<50;i++) handleInterrupt(0);
+  for(int i=0;i<10;i++) expander_handler_0();
+  count_allocations = false;
+  CHECK_EQ(allocations, 0);
+  CHECK(buttons.isButtonStorming(4));
+  CHECK(buttons.getDroppedEvents(4) > 0);
+  CHECK(buttons.getDebouncedEdges(5) > 0);
+
+  // The check itself works: the "tick" which moves the edges into the click stacks does allocate.
+  count_allocations = true;
+  buttons.tickTimer();
+  count_allocations = false;
+  CHECK(allocations > 0);
+
+  return testResult("test_isr_alloc");
+}
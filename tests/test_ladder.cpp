@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * @file    test_ladder.cpp
+  * @brief   Resistor-ladder keypad against a stubbed ADC.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+using namespace swbtns;
+
+#define ADC_PIN 34
+#define ADC_IDLE 4095
+
+static int adc_value = ADC_IDLE;
+int analogRead(uint8_t pin) {
+  return (pin == ADC_PIN) ? adc_value : ADC_IDLE;
+}
+
+static int clicks[3] = {0, 0, 0};
+static int double_clicks = 0;
+
+void onClk(int pin) { clicks[pin - 10]++; }
+void onDblClk(int pin) { double_clicks++; }
+
+int main() {
+  CSWButtons buttons;
+  const ladderThreshold thresholds[] = {{1500, 11}, {500, 10}, {2500, 12}};
+  buttons.addLadder(ADC_PIN, thresholds, 3);
+  for(int b=10;b<=12;b++) buttons.onClick(b, onClk, 1);
+  buttons.onClick(11, onDblClk, 2);
+  buttons.attachInterrupts();
+  tickFor(buttons, 100);
+
+  // A clean press.
+  adc_value = 1000;
+  tickFor(buttons, 200);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 1);
+  CHECK_EQ(clicks[0] + clicks[2], 0);
+
+  // On the way to its voltage the value passes the neighbouring band for one sample - that is not its press.
+  adc_value = 300;
+  tickFor(buttons, 25);
+  adc_value = 1000;
+  tickFor(buttons, 200);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 2);
+  CHECK_EQ(clicks[0], 0);
+
+  // The contact bounces on the release: one sample back in the idle band is not a release followed by a second press.
+  adc_value = 1000;
+  tickFor(buttons, 200);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 25);
+  adc_value = 1000;
+  tickFor(buttons, 25);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 3);
+  CHECK_EQ(double_clicks, 0);
+
+  // Two real presses are still a double click.
+  adc_value = 2000;
+  tickFor(buttons, 150);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[2], 1);
+  adc_value = 1000;
+  tickFor(buttons, 150);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 150);
+  adc_value = 1000;
+  tickFor(buttons, 150);
+  adc_value = ADC_IDLE;
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks[1], 3);
+  CHECK_EQ(double_clicks, 1);
+
+  return testResult("test_ladder");
+}
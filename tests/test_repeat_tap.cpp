@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    test_repeat_tap.cpp
+  * @brief   Auto-repeat: its acceleration, and a quick tap whose release edge is swallowed by the debounce.
+  *
+  ******************************************************************************
+  */
+
+#include "fake_pins.h"
+using namespace swbtns;
+
+#define MAX_REPEATS 64
+
+static int repeats = 0;
+static int repeat_seq[MAX_REPEATS];
+static unsigned long repeat_time[MAX_REPEATS];
+static int clicks = 0;
+static CSWButtons buttons;
+
+void onRpt(int pin, int seq) {
+  if(repeats < MAX_REPEATS) {
+    repeat_seq[repeats] = seq;
+    repeat_time[repeats] = buttons.getTimems();
+  }
+  repeats++;
+}
+void onClk(int pin) { clicks++; }
+
+/// @brief Time per repeat between the first callbacks with the sequence numbers from and to (the late tick folds several repeats into one callback)
+int repeatIntervalms(int from, int to) {
+  int a = -1, b = -1;
+  for(int i=0;i<repeats && i<MAX_REPEATS;i++) {
+    if(a == -1 && repeat_seq[i] >= from) a = i;
+    if(b == -1 && repeat_seq[i] >= to) b = i;
+  }
+  if(a == -1 || b == -1 || repeat_seq[b] == repeat_seq[a]) return -1;
+  return (repeat_time[b] - repeat_time[a]) / (repeat_seq[b] - repeat_seq[a]);
+}
+
+int main() {
+  buttons.addButton(PIN);
+  buttons.onClick(PIN, onClk, 1);
+  // The first repeat is due before the debounce time is over - only the level check can stop it.
+  // Then the intervals are 80, 40, 20, 20... ms.
+  buttons.onRepeat(PIN, onRpt, 50, 80, 20, 50);
+  buttons.attachInterrupts();
+  tickFor(buttons, 200);
+
+  // Quick tap: the release comes 30 ms after the press, within the 100 ms debounce.
+  setPin(LOW);
+  tickFor(buttons, 30);
+  setPin(HIGH);
+  tickFor(buttons, 1300);
+  CHECK_EQ(repeats, 0);
+  CHECK_EQ(clicks, 1);
+
+  // Held: the repeats come with the growing sequence number and the shrinking interval, the release gives no click and stops them.
+  setPin(LOW);
+  tickFor(buttons, 400);
+  CHECK(repeats > 10);
+  bool seq_growing = true;
+  for(int i=1;i<repeats && i<MAX_REPEATS;i++) {
+    if(repeat_seq[i] <= repeat_seq[i-1]) seq_growing = false;
+  }
+  CHECK(seq_growing);
+  int first_interval = repeatIntervalms(1, 2);
+  int second_interval = repeatIntervalms(2, 3);
+  int last = (repeats < MAX_REPEATS) ? repeats - 1 : MAX_REPEATS - 1;
+  int min_interval = repeatIntervalms(5, repeat_seq[last]);
+  CHECK(first_interval >= 70 && first_interval <= 95);
+  CHECK(second_interval >= 30 && second_interval <= 55);
+  CHECK(min_interval >= 17 && min_interval <= 25);
+  setPin(HIGH);
+  int repeats_at_release = repeats;
+  tickFor(buttons, 1300);
+  CHECK_EQ(repeats, repeats_at_release);
+  CHECK_EQ(clicks, 1);
+
+  return testResult("test_repeat_tap");
+}
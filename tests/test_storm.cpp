@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file    test_storm.cpp
+  * @brief   Interrupt storm: the pin falls back to polling and gets its interrupt back when it settles.
+  *
+  ******************************************************************************
+  */
+
+#include "fake_pins.h"
+using namespace swbtns;
+
+static int attached = 0;
+static int detached = 0;
+static bool interrupt_on = false;
+
+/// @brief Override the weak host stubs of CSWButtons.cpp
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if(pin != PIN) return;
+  attached++;
+  interrupt_on = true;
+}
+void detachInterrupt(uint8_t pin) {
+  if(pin != PIN) return;
+  detached++;
+  interrupt_on = false;
+}
+
+/// @brief The level of the pin changes, the interrupt comes only while it is attached
+void movePin(int level) {
+  if(interrupt_on) setPin(level);
+  else pin_level = level;
+}
+
+static int clicks = 0;
+static int longpresses = 0;
+
+void onClk(int pin) { clicks++; }
+void onLngPrs(int pin) { longpresses++; }
+
+int main() {
+  CSWButtons buttons;
+  buttons.addButton(PIN);
+  buttons.onClick(PIN, onClk, 1);
+  buttons.onLongpress(PIN, onLngPrs);
+  buttons.setStormProtection(10, 250, 1000, 10);
+  buttons.attachInterrupts();
+  CHECK_EQ(attached, 1);
+  tickFor(buttons, 200);
+
+  // The wet switch: 40 edges within a few ms. The handler gives up after the 10th, the tick detaches the pin.
+  for(int i=0;i<40;i++) movePin((i % 2) ? HIGH : LOW);
+  CHECK(buttons.isButtonStorming(PIN));
+  CHECK(buttons.getDroppedEvents(PIN) > 0);
+  CHECK(buttons.getDebouncedEdges(PIN) > 0);
+  buttons.tickTimer();
+  CHECK_EQ(detached, 1);
+  CHECK(!interrupt_on);
+
+  // Polled now: the integrator ignores a one-sample glitch and delivers the held level into the click stack - a longpress.
+  movePin(LOW);
+  tickFor(buttons, 100);
+  uint32_t debounced = buttons.getDebouncedEdges(PIN);
+  movePin(HIGH);
+  tickFor(buttons, 12);
+  movePin(LOW);
+  tickFor(buttons, 600);
+  CHECK(buttons.getDebouncedEdges(PIN) > debounced);
+  movePin(HIGH);
+  tickFor(buttons, 100);
+  CHECK(!interrupt_on);
+  CHECK_EQ(attached, 1);
+  tickFor(buttons, 1300);
+  CHECK_EQ(longpresses, 1);
+  CHECK_EQ(clicks, 0);
+
+  // Stable for storm_settle_ms - the interrupt is back and the button works through it again.
+  CHECK_EQ(attached, 2);
+  CHECK(interrupt_on);
+  CHECK(!buttons.isButtonStorming(PIN));
+  movePin(LOW);
+  tickFor(buttons, 150);
+  movePin(HIGH);
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks, 1);
+  CHECK_EQ(longpresses, 1);
+
+  return testResult("test_storm");
+}
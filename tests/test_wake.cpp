@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    test_wake.cpp
+  * @brief   The press which woke the chip from the deep sleep, with a stubbed wake cause provider.
+  *
+  ******************************************************************************
+  */
+
+#include "test_common.h"
+using namespace swbtns;
+
+#define PIN 4
+#define OTHER_PIN 5
+#define OTHER_BUTTON 105 //fed through pushEvent(), like the button of a backend
+
+static int wake_provider_calls = 0;
+static int clicks = 0;
+static int longpresses = 0;
+static int other_clicks = 0;
+static int other_holds = 0;
+static int latency_at_other_hold = 0;
+static CSWButtons buttons;
+
+/// @brief Woken by PIN through ext1, at the very start of the library clock (the chip boots after the deep sleep)
+uint64_t stubWakeCause(int * wake_time_ms) {
+  wake_provider_calls++;
+  *wake_time_ms = 0;
+  return 1ULL << PIN;
+}
+
+void onClk(int pin) { if(pin == PIN) clicks++; else other_clicks++; }
+void onLngPrs(int pin) { longpresses++; }
+void onOtherHld(int pin, int tier) {
+  other_holds++;
+  latency_at_other_hold = buttons.getWakeLatencyms();
+}
+
+int main() {
+  const int tiers[] = {50};
+  buttons.addButton(PIN);
+  buttons.addButton(OTHER_PIN);
+  buttons.onClick(PIN, onClk, 1);
+  buttons.onClick(OTHER_PIN, onClk, 1);
+  buttons.onLongpress(PIN, onLngPrs);
+  buttons.onHold(OTHER_BUTTON, tiers, 1, onOtherHld);
+  buttons.setWakeCauseFunction(stubWakeCause);
+  CHECK_EQ(buttons.getWakeLatencyms(), -1);
+
+  // Slow boot: the setup takes longer than the longpress interval, the button (HIGH on the host) is already released.
+  buttons.getTimems();
+  usleep(700 * 1000);
+  buttons.attachInterrupts();
+  CHECK_EQ(wake_provider_calls, 1);
+  CHECK_EQ(buttons.getWakeLatencyms(), -1);
+
+  // The other button is pressed first and its callback runs before the one of the waking button - it is not the wake latency.
+  buttons.pushEvent(OTHER_BUTTON, true);
+  tickFor(buttons, 100);
+  buttons.pushEvent(OTHER_BUTTON, false);
+  CHECK_EQ(other_holds, 1);
+  CHECK_EQ(latency_at_other_hold, -1);
+  CHECK_EQ(buttons.getWakeLatencyms(), -1);
+
+  tickFor(buttons, 1300);
+  CHECK_EQ(clicks, 1);
+  CHECK_EQ(longpresses, 0);
+  CHECK_EQ(other_clicks, 0);
+  // From the wake (0) to the click callback: the boot plus the multiclick window.
+  int latency = buttons.getWakeLatencyms();
+  CHECK(latency >= 1000);
+  CHECK(latency < 2500);
+
+  return testResult("test_wake");
+}